@@ -0,0 +1,43 @@
+#include <string>
+#include <vector>
+
+using namespace libsnark;
+
+/*
+    A compiled sudoku circuit: the R1CS constraint system for a given n,
+    together with the SHA256 of its serialization. It is persisted as
+    "<n>.r1cs" next to the keys so that keygen and the prover don't have
+    to re-run generate_r1cs_constraints() every time. The constraint system
+    is stored with A/B swapped (see compile_circuit).
+*/
+template<typename FieldT>
+class sudoku_circuit {
+public:
+    uint32_t n;
+    r1cs_constraint_system<FieldT> constraint_system;
+    std::vector<unsigned char> hash; // 32 bytes
+
+    sudoku_circuit() : n(0) {}
+};
+
+std::string circuit_path(uint32_t n);
+
+template<typename FieldT>
+std::vector<unsigned char> hash_constraint_system(const r1cs_constraint_system<FieldT> &constraint_system);
+
+template<typename FieldT>
+sudoku_circuit<FieldT> compile_circuit(uint32_t n);
+
+template<typename FieldT>
+bool save_circuit(const std::string &path, const sudoku_circuit<FieldT> &circuit);
+
+template<typename FieldT>
+bool load_circuit(const std::string &path, uint32_t n, sudoku_circuit<FieldT> &circuit);
+
+template<typename FieldT>
+bool circuit_fits_layout(const sudoku_circuit<FieldT> &circuit, const protoboard<FieldT> &pb);
+
+template<typename FieldT>
+const sudoku_circuit<FieldT>& get_circuit(uint32_t n);
+
+#include "circuit.tcc"
@@ -0,0 +1,405 @@
+#include "sha256.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+    CIRCUIT_FINGERPRINT identifies everything the circuit is built from that
+    this file can't see: the Makefile sets it to the SHA256 of gadget.hpp,
+    gadget.tcc and the installed libsnark gadgetlib1 headers and library.
+    Builds that don't set it fall back to the build time, so their circuit
+    files are recompiled after every rebuild.
+*/
+#ifndef CIRCUIT_FINGERPRINT
+#define CIRCUIT_FINGERPRINT __DATE__ " " __TIME__
+#endif
+
+// libsnark's stream operators change format with these
+static const char circuit_output_flags[] =
+#ifdef BINARY_OUTPUT
+    " BINARY_OUTPUT"
+#endif
+#ifdef MONTGOMERY_OUTPUT
+    " MONTGOMERY_OUTPUT"
+#endif
+#ifdef NO_PT_COMPRESSION
+    " NO_PT_COMPRESSION"
+#endif
+    "";
+
+/*
+    On-disk layout of "<n>.r1cs" (host byte order, like the keys):
+
+        magic       8 bytes   "p2s-r1cs"
+        version     uint32
+        n           uint32
+        field_bits  uint32    FieldT::num_bits
+        field_hash  32 bytes  SHA256 of FieldT::num_bits and FieldT::mod
+        build       32 bytes  SHA256 of CIRCUIT_FINGERPRINT and the output flags
+        flags       uint32    circuit_has_annotations
+        body_len    uint64
+        hash        32 bytes  SHA256(body)
+        body        body_len bytes, libsnark serialization of the constraint system
+
+    and, only if circuit_has_annotations is set:
+
+        variable annotations    uint64 count, then (uint64 index, uint64 len, bytes)*
+        constraint annotations  same as above
+
+    libsnark only keeps annotations when built with DEBUG, which the Makefile
+    doesn't set. A DEBUG build recompiles files written without them.
+    Annotations are kept out of the hash, so DEBUG and release builds agree on it.
+*/
+static const char circuit_magic[8] = {'p', '2', 's', '-', 'r', '1', 'c', 's'};
+static const uint32_t circuit_version = 3;
+static const uint32_t circuit_has_annotations = 1;
+static const size_t circuit_header_size = 8 + 4 + 4 + 4 + 32 + 32 + 4 + 8 + 32;
+
+std::string circuit_path(uint32_t n) {
+    std::stringstream ss;
+    ss << n << ".r1cs";
+    return ss.str();
+}
+
+class circuit_buffer : public std::streambuf {
+public:
+    circuit_buffer(const char *data, size_t len) {
+        char *p = const_cast<char*>(data);
+        setg(p, p, p + len);
+    }
+};
+
+static std::vector<unsigned char> sha256_bytes(const char *data, size_t len) {
+    std::vector<unsigned char> hash(SHA256_BLOCK_SIZE);
+
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, reinterpret_cast<const BYTE*>(data), len);
+    sha256_final(&ctx, &hash[0]);
+
+    return hash;
+}
+
+#ifdef DEBUG
+static void write_annotations(std::ostream &out, const std::map<size_t, std::string> &annotations) {
+    uint64_t count = annotations.size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+
+    for (auto it = annotations.begin(); it != annotations.end(); ++it) {
+        uint64_t index = it->first;
+        uint64_t len = it->second.size();
+        out.write(reinterpret_cast<const char*>(&index), sizeof(index));
+        out.write(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.write(it->second.data(), len);
+    }
+}
+
+static bool read_annotations(const char *&p, const char *end, std::map<size_t, std::string> &annotations) {
+    uint64_t count;
+    if ((size_t)(end - p) < sizeof(count)) {
+        return false;
+    }
+    memcpy(&count, p, sizeof(count));
+    p += sizeof(count);
+
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t index, len;
+        if ((size_t)(end - p) < sizeof(index) + sizeof(len)) {
+            return false;
+        }
+        memcpy(&index, p, sizeof(index));
+        memcpy(&len, p + sizeof(index), sizeof(len));
+        p += sizeof(index) + sizeof(len);
+
+        if ((uint64_t)(end - p) < len) {
+            return false;
+        }
+        annotations[index] = std::string(p, len);
+        p += len;
+    }
+
+    return true;
+}
+#endif
+
+static std::vector<unsigned char> build_fingerprint()
+{
+    std::string s = std::string(CIRCUIT_FINGERPRINT) + circuit_output_flags;
+
+    return sha256_bytes(s.data(), s.size());
+}
+
+template<typename FieldT>
+static std::vector<unsigned char> field_fingerprint()
+{
+    std::stringstream ss;
+    ss << FieldT::num_bits << " " << FieldT::mod;
+    std::string s = ss.str();
+
+    return sha256_bytes(s.data(), s.size());
+}
+
+template<typename FieldT>
+std::vector<unsigned char> hash_constraint_system(const r1cs_constraint_system<FieldT> &constraint_system)
+{
+    std::stringstream ss;
+    ss << constraint_system;
+    std::string body = ss.str();
+
+    return sha256_bytes(body.data(), body.size());
+}
+
+template<typename FieldT>
+sudoku_circuit<FieldT> compile_circuit(uint32_t n)
+{
+    protoboard<FieldT> pb;
+    sudoku_gadget<FieldT> g(pb, n);
+    g.generate_r1cs_constraints();
+
+    sudoku_circuit<FieldT> circuit;
+    circuit.n = n;
+    circuit.constraint_system = pb.get_constraint_system();
+    // The ppzkSNARK generator may swap A/B in the copy it keeps in the
+    // proving key. swap_AB_if_beneficial() is idempotent, so storing the
+    // swapped form lets keypair_matches_circuit compare the two after
+    // swapping the key's copy too, whether or not the generator did.
+    circuit.constraint_system.swap_AB_if_beneficial();
+    circuit.hash = hash_constraint_system(circuit.constraint_system);
+
+    return circuit;
+}
+
+template<typename FieldT>
+bool save_circuit(const std::string &path, const sudoku_circuit<FieldT> &circuit)
+{
+    std::string body;
+    {
+        std::stringstream ss;
+        ss << circuit.constraint_system;
+        body = ss.str();
+    }
+    assert(circuit.hash.size() == SHA256_BLOCK_SIZE);
+
+    // other processes may have path mmapped, so never truncate it in place:
+    // write a temporary file next to it and rename it over path. A process
+    // killed in between leaves "<path>.tmp.<pid>" behind (make clean removes it).
+    std::string tmp_path;
+    {
+        std::stringstream ss;
+        ss << path << ".tmp." << getpid();
+        tmp_path = ss.str();
+    }
+
+    ofstream out(tmp_path, ios::binary | ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    uint32_t field_bits = FieldT::num_bits;
+    std::vector<unsigned char> field_hash = field_fingerprint<FieldT>();
+    std::vector<unsigned char> build_hash = build_fingerprint();
+#ifdef DEBUG
+    uint32_t flags = circuit_has_annotations;
+#else
+    uint32_t flags = 0;
+#endif
+    uint64_t body_len = body.size();
+    out.write(circuit_magic, sizeof(circuit_magic));
+    out.write(reinterpret_cast<const char*>(&circuit_version), sizeof(circuit_version));
+    out.write(reinterpret_cast<const char*>(&circuit.n), sizeof(circuit.n));
+    out.write(reinterpret_cast<const char*>(&field_bits), sizeof(field_bits));
+    out.write(reinterpret_cast<const char*>(&field_hash[0]), SHA256_BLOCK_SIZE);
+    out.write(reinterpret_cast<const char*>(&build_hash[0]), SHA256_BLOCK_SIZE);
+    out.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+    out.write(reinterpret_cast<const char*>(&body_len), sizeof(body_len));
+    out.write(reinterpret_cast<const char*>(&circuit.hash[0]), SHA256_BLOCK_SIZE);
+    out.write(body.data(), body.size());
+
+#ifdef DEBUG
+    write_annotations(out, circuit.constraint_system.variable_annotations);
+    write_annotations(out, circuit.constraint_system.constraint_annotations);
+#endif
+
+    out.close();
+    if (out.fail() || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+template<typename FieldT>
+static bool parse_circuit(const char *data, size_t size, uint32_t n, sudoku_circuit<FieldT> &circuit)
+{
+    if (size < circuit_header_size || memcmp(data, circuit_magic, sizeof(circuit_magic)) != 0) {
+        return false;
+    }
+
+    const char *p = data + sizeof(circuit_magic);
+
+    uint32_t version, file_n, field_bits;
+    memcpy(&version, p, sizeof(version));
+    p += sizeof(version);
+    memcpy(&file_n, p, sizeof(file_n));
+    p += sizeof(file_n);
+    memcpy(&field_bits, p, sizeof(field_bits));
+    p += sizeof(field_bits);
+
+    if (version != circuit_version || file_n != n || field_bits != FieldT::num_bits) {
+        return false;
+    }
+
+    std::vector<unsigned char> field_hash(p, p + SHA256_BLOCK_SIZE);
+    p += SHA256_BLOCK_SIZE;
+
+    if (field_hash != field_fingerprint<FieldT>()) {
+        return false;
+    }
+
+    std::vector<unsigned char> build_hash(p, p + SHA256_BLOCK_SIZE);
+    p += SHA256_BLOCK_SIZE;
+
+    if (build_hash != build_fingerprint()) {
+        return false;
+    }
+
+    uint32_t flags;
+    memcpy(&flags, p, sizeof(flags));
+    p += sizeof(flags);
+
+    uint64_t body_len;
+    memcpy(&body_len, p, sizeof(body_len));
+    p += sizeof(body_len);
+
+    if (body_len > size - circuit_header_size) {
+        return false;
+    }
+
+    std::vector<unsigned char> hash(p, p + SHA256_BLOCK_SIZE);
+    p += SHA256_BLOCK_SIZE;
+
+    const char *body = p;
+
+    if (sha256_bytes(body, body_len) != hash) {
+        return false;
+    }
+
+    {
+        circuit_buffer buf(body, body_len);
+        std::istream in(&buf);
+        in >> circuit.constraint_system;
+        if (in.fail()) {
+            return false;
+        }
+    }
+
+    p = body + body_len;
+    const char *end = data + size;
+#ifdef DEBUG
+    if (!(flags & circuit_has_annotations) ||
+        !read_annotations(p, end, circuit.constraint_system.variable_annotations) ||
+        !read_annotations(p, end, circuit.constraint_system.constraint_annotations)) {
+        return false;
+    }
+#else
+    // release builds of libsnark have nowhere to put annotations
+    (void)end;
+#endif
+
+    circuit.n = n;
+    circuit.hash = hash;
+
+    return true;
+}
+
+template<typename FieldT>
+bool load_circuit(const std::string &path, uint32_t n, sudoku_circuit<FieldT> &circuit)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    size_t size = st.st_size;
+    void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    bool ok = parse_circuit(reinterpret_cast<const char*>(data), size, n, circuit);
+    munmap(data, size);
+
+    return ok;
+}
+
+template<typename FieldT>
+bool circuit_fits_layout(const sudoku_circuit<FieldT> &circuit, const protoboard<FieldT> &pb)
+{
+    return circuit.constraint_system.num_inputs() == pb.num_inputs() &&
+           circuit.constraint_system.num_variables() == pb.num_variables();
+}
+
+/*
+    Returns the compiled circuit for n, loading it from circuit_path(n) or
+    compiling and saving it if the file is missing, corrupt, was written by
+    another build or for another field, or doesn't fit the layout of the
+    current sudoku_gadget. Circuits are cached for the life of the process.
+*/
+template<typename FieldT>
+const sudoku_circuit<FieldT>& get_circuit(uint32_t n)
+{
+    static std::map<uint32_t, sudoku_circuit<FieldT>> circuits;
+    static std::mutex circuits_lock;
+
+    std::lock_guard<std::mutex> guard(circuits_lock);
+
+    auto it = circuits.find(n);
+    if (it != circuits.end()) {
+        return it->second;
+    }
+
+    const std::string path = circuit_path(n);
+    sudoku_circuit<FieldT> &circuit = circuits[n];
+
+    bool loaded = load_circuit(path, n, circuit);
+    if (loaded) {
+        // laying out the gadget is cheap; it's generating its constraints that isn't
+        protoboard<FieldT> pb;
+        sudoku_gadget<FieldT> g(pb, n);
+
+        loaded = circuit_fits_layout(circuit, pb);
+    }
+
+    if (!loaded) {
+        cout << "Compiling circuit to " << path << "..." << endl;
+        circuit = compile_circuit<FieldT>(n);
+
+        if (!save_circuit(path, circuit)) {
+            cerr << "Could not write " << path << endl;
+        }
+    }
+
+    return circuit;
+}
@@ -81,6 +81,12 @@ extern "C" void* load_keypair(const char* pk_s, int32_t pk_l, const char* vk_s,
     return reinterpret_cast<void*>(new r1cs_ppzksnark_keypair<default_r1cs_ppzksnark_pp>(std::move(pk), std::move(vk)));
 }
 
+extern "C" bool check_keypair(void *keypair, uint32_t n) {
+    auto our_keypair = reinterpret_cast<r1cs_ppzksnark_keypair<default_r1cs_ppzksnark_pp>*>(keypair);
+
+    return keypair_matches_circuit<default_r1cs_ppzksnark_pp>(n, *our_keypair);
+}
+
 extern "C" bool gen_proof(void *keypair, void* h, proof_callback cb, uint32_t n, uint8_t* puzzle, uint8_t* solution, uint8_t* input_key, uint8_t* input_h_of_key) {
     auto our_keypair = reinterpret_cast<r1cs_ppzksnark_keypair<default_r1cs_ppzksnark_pp>*>(keypair);
 
@@ -98,6 +98,9 @@ boost::optional<std::tuple<r1cs_ppzksnark_proof<ppzksnark_ppT>,std::vector<std::
                  std::vector<bool> &h_of_key
                  );
 
+template<typename ppzksnark_ppT>
+bool keypair_matches_circuit(uint32_t n, const r1cs_ppzksnark_keypair<ppzksnark_ppT> &keypair);
+
 template<typename ppzksnark_ppT>
 bool verify_proof(uint32_t n,
                   r1cs_ppzksnark_verification_key<ppzksnark_ppT> verification_key,
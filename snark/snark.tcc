@@ -1,8 +1,10 @@
 #include "gadget.hpp"
+#include "circuit.hpp"
 #include "sha256.h"
 
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
 using namespace std;
 
 std::vector<std::vector<bool>> convertPuzzleToBool(std::vector<uint8_t> puzzle) {
@@ -96,10 +98,7 @@ r1cs_ppzksnark_keypair<ppzksnark_ppT> generate_keypair(uint32_t n)
 {
     typedef Fr<ppzksnark_ppT> FieldT;
 
-    protoboard<FieldT> pb;
-    sudoku_gadget<FieldT> g(pb, n);
-    g.generate_r1cs_constraints();
-    const r1cs_constraint_system<FieldT> constraint_system = pb.get_constraint_system();
+    const r1cs_constraint_system<FieldT> &constraint_system = get_circuit<FieldT>(n).constraint_system;
 
     cout << "Number of R1CS constraints: " << constraint_system.num_constraints() << endl;
 		
@@ -111,10 +110,7 @@ r1cs_ppzksnark_keypair<ppzksnark_ppT> malicious_generate_keypair(uint32_t n)
 {
     typedef Fr<ppzksnark_ppT> FieldT;
 
-    protoboard<FieldT> pb;
-    sudoku_gadget<FieldT> g(pb, n);
-    g.generate_r1cs_constraints();
-    const r1cs_constraint_system<FieldT> constraint_system = pb.get_constraint_system();
+    const r1cs_constraint_system<FieldT> &constraint_system = get_circuit<FieldT>(n).constraint_system;
 
     cout << "Number of R1CS constraints: " << constraint_system.num_constraints() << endl;
 		
@@ -133,17 +129,24 @@ boost::optional<std::tuple<r1cs_ppzksnark_proof<ppzksnark_ppT>,std::vector<std::
 {
     typedef Fr<ppzksnark_ppT> FieldT;
 
+    const sudoku_circuit<FieldT> &circuit = get_circuit<FieldT>(n);
+
+    // the constraints come from the compiled circuit, the gadget
+    // is only needed to lay out and fill in the witness
     protoboard<FieldT> pb;
     sudoku_gadget<FieldT> g(pb, n);
-    g.generate_r1cs_constraints();
 
     auto new_puzzle = convertPuzzleToBool(puzzle);
     auto new_solution = convertPuzzleToBool(solution);
     auto encrypted_solution = xorSolution(new_solution, key);
 
+    if (!circuit_fits_layout(circuit, pb)) {
+        throw std::runtime_error("compiled circuit doesn't fit the layout of sudoku_gadget");
+    }
+
     g.generate_r1cs_witness(new_puzzle, new_solution, key, h_of_key, encrypted_solution);
 
-    if (!pb.is_satisfied()) {
+    if (!circuit.constraint_system.is_satisfied(pb.primary_input(), pb.auxiliary_input())) {
         return boost::none;
     }
 
@@ -153,6 +156,24 @@ boost::optional<std::tuple<r1cs_ppzksnark_proof<ppzksnark_ppT>,std::vector<std::
     );
 }
 
+template<typename ppzksnark_ppT>
+bool keypair_matches_circuit(uint32_t n, const r1cs_ppzksnark_keypair<ppzksnark_ppT> &keypair)
+{
+    typedef Fr<ppzksnark_ppT> FieldT;
+
+    const sudoku_circuit<FieldT> &circuit = get_circuit<FieldT>(n);
+
+    if (keypair.vk.encoded_IC_query.domain_size() != circuit.constraint_system.num_inputs()) {
+        return false;
+    }
+
+    // see compile_circuit
+    r1cs_constraint_system<FieldT> constraint_system(keypair.pk.constraint_system);
+    constraint_system.swap_AB_if_beneficial();
+
+    return hash_constraint_system(constraint_system) == circuit.hash;
+}
+
 template<typename ppzksnark_ppT>
 bool verify_proof(uint32_t n,
                   r1cs_ppzksnark_verification_key<ppzksnark_ppT> verification_key,
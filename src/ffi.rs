@@ -22,6 +22,7 @@ extern "C" {
     fn malicious_gen_keypair(n: uint32_t, h: *mut c_void, cb: extern fn(*mut c_void, *const c_char, size_t, *const c_char, size_t));
     fn load_keypair(pk_s: *const c_char, pk_l: int32_t, vk_s: *const c_char, vk_l: int32_t)
         -> *const Keypair;
+    fn check_keypair(keypair: *const Keypair, n: uint32_t) -> bool;
     fn gen_proof(keypair: *const Keypair, h: *mut c_void,
                  cb: extern fn(*mut c_void, uint32_t, *const uint8_t, *const c_char, int32_t), 
                  n: uint32_t, puzzle: *const uint8_t, solution: *const uint8_t,
@@ -93,6 +94,14 @@ pub fn get_context(pk: &[u8], vk: &[u8], n: usize) -> Context {
     }
 }
 
+pub fn check_context(ctx: &Context) -> Result<(), String> {
+    if unsafe { check_keypair(ctx.keypair, ctx.n as u32) } {
+        Ok(())
+    } else {
+        Err(format!("keypair doesn't match the compiled {}x{} circuit ({}.r1cs)", ctx.n*ctx.n, ctx.n*ctx.n, ctx.n))
+    }
+}
+
 pub fn prove<F: for<'a> FnMut(&'a [u8], &'a [u8])>(ctx: &Context, puzzle: &[u8], solution: &[u8], key: &[u8], h_of_key: &[u8], mut f: F) -> bool {
     let mut cb: &mut for<'a> FnMut(&'a [u8], &'a [u8]) = &mut f;
 
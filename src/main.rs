@@ -112,6 +112,10 @@ fn main() {
             get_context(&pk, &vk, n)
         };
 
+        if let Err(e) = check_context(&ctx) {
+            println!("Warning: {}", e);
+        }
+
         let mut stream = TcpStream::connect("127.0.0.1:25519").unwrap();
 
         handle_server(&mut stream, &ctx, n, &mut rpc);
@@ -132,6 +136,10 @@ fn main() {
             get_context(&pk, &vk, n)
         };
 
+        if let Err(e) = check_context(&ctx) {
+            println!("Warning: {}", e);
+        }
+
         let listener = TcpListener::bind("0.0.0.0:25519").unwrap();
         println!("Opened listener. Instruct client to connect.");
 
@@ -161,6 +169,10 @@ fn main() {
             get_context(&pk, &vk, n)
         };
 
+        if let Err(e) = check_context(&ctx) {
+            println!("Warning: {}", e);
+        }
+
         loop {
             println!("Generating puzzle...");
             let puzzle = Sudoku::gen(n);